@@ -2,6 +2,11 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 // Headers as needed
 
@@ -24,6 +29,12 @@ typedef struct Process {
 
     uint32_t IOBurst;                   // The amount of time until the process finishes being blocked
     uint32_t CPUBurst;                  // The CPU availability of the process (has to be > 1 to move to running)
+    uint32_t IOBurstEnd;                // The total I/O time at which the current I/O burst finishes
+    uint32_t CPUBurstEnd;               // The total CPU time at which the current CPU burst finishes
+
+    const uint32_t* traceBursts;        // (CPU, I/O) burst pairs inside the mapped trace file, NULL for (A B C M) input
+    uint32_t numTraceBursts;            // The number of (CPU, I/O) burst pairs in the trace
+    uint32_t CPUBurstIndex;             // The trace burst pair the current CPU burst was taken from
 
     int32_t quantum;                    // Used for schedulers that utilise pre-emption
 
@@ -44,7 +55,32 @@ uint32_t TOTAL_NUMBER_OF_CYCLES_SPENT_BLOCKED = 0; // The total cycles in the bl
 const char* RANDOM_NUMBER_FILE_NAME = "random-numbers";
 const uint32_t SEED_VALUE = 200;  // Seed value for reading from file
 
+/*
+    Binary trace format (native byte order, every field a uint32_t so the mapping can be read in place):
+        header:       magic "SCHT", version, number of processes
+        per process:  arrival time, number of burst pairs N, then N (CPU burst, I/O burst) pairs
+    Every burst must be at least 1 cycle. The I/O burst of the final pair is still needed, since Round Robin
+    blocks a process whose quantum expires for the length of its current I/O burst.
+*/
+const char TRACE_MAGIC[4] = { 'S', 'C', 'H', 'T' };
+const uint32_t TRACE_VERSION = 1;
+const uint32_t TRACE_HEADER_WORDS = 3;
+const uint32_t MAX_TRACE_PROCESSES = 3; // The ready queue (determineQueue/determineSJF) only orders up to three processes
+const uint32_t MAX_TRACE_CPU_TIME = 1000000; // The largest total CPU time (C) accepted for a trace process
+
+const uint32_t* TRACE_MAPPING = NULL;   // The mapped trace file, if the input is a binary trace
+size_t TRACE_MAPPING_SIZE = 0;          // The size of the mapped trace file in bytes
+
 // Additional variables as needed
+uint32_t CONTEXT_SWITCH_COST = 0;       // Cycles charged every time the CPU switches to a different process (--switch-cost)
+uint32_t CACHE_WARMUP_COST = 0;         // Extra cycles charged when the process switched to has run before (--warmup-cost)
+const uint32_t MAX_DISPATCH_COST = 1000; // The largest cost accepted for either option
+
+uint32_t TOTAL_CONTEXT_SWITCHES = 0;    // The total number of context switches
+uint32_t TOTAL_SWITCH_OVERHEAD_CYCLES = 0; // The total cycles the CPU spent switching instead of running a process
+uint32_t SWITCH_CYCLES_REMAINING = 0;   // The cycles left to pay for the current context switch
+bool IS_SWITCHING_CONTEXT = false;      // Whether the current cycle is spent on a context switch
+_process* LAST_RUN_PROCESS = NULL;      // The process the CPU was last dispatched to
 
 
 /**
@@ -182,6 +218,8 @@ void printSummaryData(_process process_list[])
     printf("Summary Data:\n");
     printf("\tFinishing time: %i\n", final_finishing_time);
     printf("\tCPU Utilisation: %6f\n", cpu_util);
+    printf("\tContext switches: %i\n", TOTAL_CONTEXT_SWITCHES);
+    printf("\tContext switch overhead: %i cycles\n", TOTAL_SWITCH_OVERHEAD_CYCLES);
     printf("\tI/O Utilisation: %6f\n", io_util);
     printf("\tThroughput: %6f processes per hundred cycles\n", throughput);
     printf("\tAverage turnaround time: %6f\n", avg_turnaround_time);
@@ -198,6 +236,277 @@ void readProcess(FILE* file, _process* process)
     fscanf(file, "%d %d %d %d", &process->A, &process->B, &process->C, &process->M);
     // Read up until the closing parenthesis
     while (fscanf(file, "%c", &ch) && ch != ')');
+
+    process->traceBursts = NULL; // bursts come from randomOS()
+    process->numTraceBursts = 0;
+}
+
+/**
+ * Maps a binary trace file and builds the process list from it. The burst pairs are not copied;
+ * each process points at its own pairs inside the mapping, which stays mapped until freeTrace().
+ * Returns 1 if the file was loaded, 0 if it is not a trace file (so it should be read as text), -1 on a malformed trace.
+ * For trace processes, B is the longest CPU burst, C the sum of the CPU bursts and M is 0.
+ */
+int loadTrace(const char* file_name, _process** process_list, uint32_t* total_num_of_process)
+{
+    int fd = open(file_name, O_RDONLY);
+    if (fd < 0) return 0;
+
+    struct stat st;
+    char magic[sizeof(TRACE_MAGIC)];
+    if (fstat(fd, &st) < 0 || read(fd, magic, sizeof(magic)) != sizeof(magic) ||
+        memcmp(magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0)
+    {
+        close(fd);
+        return 0;
+    }
+    if ((size_t)st.st_size < TRACE_HEADER_WORDS * sizeof(uint32_t))
+    {
+        fprintf(stderr, "%s: trace is truncated in its header\n", file_name);
+        close(fd);
+        return -1;
+    }
+
+    const uint32_t* words = (const uint32_t*)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (words == MAP_FAILED)
+    {
+        perror(file_name);
+        return -1;
+    }
+    madvise((void*)words, st.st_size, MADV_SEQUENTIAL);
+
+    size_t num_words = st.st_size / sizeof(uint32_t);
+    if (words[1] != TRACE_VERSION)
+    {
+        fprintf(stderr, "%s: unsupported trace version %u\n", file_name, words[1]);
+        munmap((void*)words, st.st_size);
+        return -1;
+    }
+
+    uint32_t count = words[2];
+    if (count == 0 || count > (num_words - TRACE_HEADER_WORDS) / 4) // every process needs at least one burst pair
+    {
+        fprintf(stderr, "%s: trace header claims %u processes\n", file_name, count);
+        munmap((void*)words, st.st_size);
+        return -1;
+    }
+    if (count > MAX_TRACE_PROCESSES)
+    {
+        fprintf(stderr, "%s: trace has %u processes, the scheduler supports at most %u\n", file_name, count, MAX_TRACE_PROCESSES);
+        munmap((void*)words, st.st_size);
+        return -1;
+    }
+
+    _process* list = (_process*)malloc(count * sizeof(_process));
+    if (!list)
+    {
+        perror(file_name);
+        munmap((void*)words, st.st_size);
+        return -1;
+    }
+    size_t pos = TRACE_HEADER_WORDS;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (pos + 2 > num_words || words[pos + 1] == 0 || words[pos + 1] > (num_words - pos - 2) / 2)
+        {
+            fprintf(stderr, "%s: trace is truncated at process %u\n", file_name, i);
+            free(list);
+            munmap((void*)words, st.st_size);
+            return -1;
+        }
+
+        list[i].A = words[pos];
+        list[i].numTraceBursts = words[pos + 1];
+        list[i].traceBursts = &words[pos + 2];
+        list[i].B = 0;
+        list[i].M = 0;
+        uint64_t cpu_time = 0; // summed wide so a corrupt trace can't wrap C
+        for (uint32_t j = 0; j < list[i].numTraceBursts; ++j)
+        {
+            uint32_t cpu_burst = list[i].traceBursts[2 * j];
+            if (cpu_burst == 0 || list[i].traceBursts[2 * j + 1] == 0)
+            {
+                fprintf(stderr, "%s: process %u has a burst of 0 cycles\n", file_name, i);
+                free(list);
+                munmap((void*)words, st.st_size);
+                return -1;
+            }
+            if (cpu_burst > list[i].B) list[i].B = cpu_burst;
+            cpu_time += cpu_burst;
+        }
+        if (cpu_time > MAX_TRACE_CPU_TIME)
+        {
+            fprintf(stderr, "%s: process %u needs %llu CPU cycles, at most %u are supported\n", file_name, i,
+                (unsigned long long)cpu_time, MAX_TRACE_CPU_TIME);
+            free(list);
+            munmap((void*)words, st.st_size);
+            return -1;
+        }
+        list[i].C = (uint32_t)cpu_time;
+        pos += 2 + 2 * (size_t)list[i].numTraceBursts;
+    }
+
+    TRACE_MAPPING = words;
+    TRACE_MAPPING_SIZE = st.st_size;
+    *process_list = list;
+    *total_num_of_process = count;
+    return 1;
+}
+
+// Unmaps the trace file loaded by loadTrace(), if any
+void freeTrace(void)
+{
+    if (TRACE_MAPPING) munmap((void*)TRACE_MAPPING, TRACE_MAPPING_SIZE);
+    TRACE_MAPPING = NULL;
+    TRACE_MAPPING_SIZE = 0;
+}
+
+/**
+ * Parses the unsigned CSV field at *cursor, which must be followed by separator (or by the end of the line when separator is 0),
+ * and moves *cursor past the separator. Returns 1 on success, 0 if the field is not a number that fits in a uint32_t.
+ */
+int parseCSVField(const char** cursor, char separator, uint32_t* value)
+{
+    const char* str = *cursor;
+    char* end;
+
+    while (*str == ' ' || *str == '\t') ++str;
+    if (*str < '0' || *str > '9') return 0; // strtoul would accept a sign
+    errno = 0;
+    unsigned long parsed = strtoul(str, &end, 10);
+    if (errno == ERANGE || parsed > UINT32_MAX) return 0;
+
+    while (*end == ' ' || *end == '\t' || (!separator && (*end == '\r' || *end == '\n'))) ++end;
+    if (*end != separator) return 0;
+
+    *value = (uint32_t)parsed;
+    *cursor = separator ? end + 1 : end;
+    return 1;
+}
+
+/**
+ * Converts a CSV trace into the binary trace format.
+ * Each line is "process,arrival,cpu_burst,io_burst" for one burst pair; the lines of a process must be consecutive
+ * and in burst order. Empty lines, lines starting with '#' and a header on the first line are skipped.
+ * Returns 0 on success, 1 otherwise.
+ */
+int convertCSVToTrace(const char* csv_file_name, const char* trace_file_name)
+{
+    FILE* csv_file = fopen(csv_file_name, "r");
+    if (!csv_file)
+    {
+        perror(csv_file_name);
+        return 1;
+    }
+
+    size_t capacity = 64, num_words = TRACE_HEADER_WORDS, count_pos = 0;
+    uint32_t* words = (uint32_t*)malloc(capacity * sizeof(uint32_t));
+    uint32_t* seen_ids = (uint32_t*)malloc(capacity * sizeof(uint32_t)); // ids of the processes already started
+    uint32_t num_processes = 0, line_number = 0;
+    uint32_t id, arrival, cpu_burst, io_burst;
+    const char* error = NULL;
+    char line[512];
+    uint64_t process_cpu_time = 0; // total CPU time of the process being read
+    const char* cursor;
+
+    while (fgets(line, sizeof(line), csv_file))
+    {
+        ++line_number;
+        size_t length = strlen(line);
+        if (length == sizeof(line) - 1 && line[length - 1] != '\n' && !feof(csv_file))
+        {
+            error = "line is longer than 510 characters";
+            break;
+        }
+        if (line[0] == '\n' || (line[0] == '\r' && line[1] == '\n') || line[0] == '#') continue;
+        if (line_number == 1 && ((line[0] >= 'a' && line[0] <= 'z') || (line[0] >= 'A' && line[0] <= 'Z'))) continue; // header
+
+        cursor = line;
+        if (line[0] < '0' || line[0] > '9' ||
+            !parseCSVField(&cursor, ',', &id) || !parseCSVField(&cursor, ',', &arrival) ||
+            !parseCSVField(&cursor, ',', &cpu_burst) || !parseCSVField(&cursor, '\0', &io_burst))
+        {
+            error = "expected process,arrival,cpu_burst,io_burst as whole numbers up to 4294967295";
+            break;
+        }
+        if (cpu_burst == 0 || io_burst == 0)
+        {
+            error = "bursts must be at least 1 cycle";
+            break;
+        }
+
+        if (num_words + 4 > capacity)
+        {
+            capacity *= 2;
+            words = (uint32_t*)realloc(words, capacity * sizeof(uint32_t));
+            seen_ids = (uint32_t*)realloc(seen_ids, capacity * sizeof(uint32_t));
+        }
+
+        if (num_processes == 0 || id != seen_ids[num_processes - 1]) // start a new process
+        {
+            for (uint32_t i = 0; i < num_processes; ++i)
+            {
+                if (seen_ids[i] == id) error = "lines of a process are not consecutive";
+            }
+            if (!error && num_processes == MAX_TRACE_PROCESSES) error = "more than 3 processes, which the ready queue does not support";
+            if (error) break;
+
+            words[num_words] = arrival;
+            count_pos = num_words + 1;
+            words[count_pos] = 0;
+            num_words += 2;
+            seen_ids[num_processes++] = id;
+            process_cpu_time = 0;
+        }
+        else if (words[count_pos - 1] != arrival)
+        {
+            error = "arrival time differs from earlier lines of the process";
+            break;
+        }
+
+        process_cpu_time += cpu_burst;
+        if (process_cpu_time > MAX_TRACE_CPU_TIME)
+        {
+            error = "total CPU time of the process is over 1000000 cycles";
+            break;
+        }
+
+        words[num_words++] = cpu_burst;
+        words[num_words++] = io_burst;
+        ++words[count_pos];
+    }
+    fclose(csv_file);
+    free(seen_ids);
+
+    if (!error && num_processes == 0)
+    {
+        error = "no processes";
+        line_number = 0;
+    }
+    if (error)
+    {
+        if (line_number) fprintf(stderr, "%s:%u: %s\n", csv_file_name, line_number, error);
+        else fprintf(stderr, "%s: %s\n", csv_file_name, error);
+        free(words);
+        return 1;
+    }
+
+    memcpy(words, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    words[1] = TRACE_VERSION;
+    words[2] = num_processes;
+
+    FILE* trace_file = fopen(trace_file_name, "wb");
+    if (!trace_file || fwrite(words, sizeof(uint32_t), num_words, trace_file) != num_words)
+    {
+        perror(trace_file_name);
+        if (trace_file) fclose(trace_file);
+        free(words);
+        return 1;
+    }
+    fclose(trace_file);
+    free(words);
+    return 0;
 }
 
 // Function for initializing a process before simulation
@@ -210,8 +519,11 @@ void initializeProcess(_process* process)
     process->currentIOBlockedTime = 0;
     process->currentWaitingTime = 0;
 
-    process->IOBurst = 0;
-    process->CPUBurst = 0;
+    process->IOBurst = process->traceBursts ? process->traceBursts[1] : 0; // trace bursts are known before the first run
+    process->CPUBurst = process->traceBursts ? process->traceBursts[0] : 0;
+    process->IOBurstEnd = process->IOBurst;
+    process->CPUBurstEnd = process->CPUBurst;
+    process->CPUBurstIndex = 0;
 
     process->quantum = 2;
 
@@ -225,8 +537,36 @@ void initializeProcess(_process* process)
 // Obtain burst times upon isFirstTimeRunning
 void obtainBurstTimes(_process* process, FILE* randNumFile)
 {
+    if (process->traceBursts) return; // trace processes carry their own bursts, set by initializeProcess()
+
     process->CPUBurst = randomOS(process->B, process->processID, randNumFile);
     process->IOBurst = process->CPUBurst * process->M;
+    process->CPUBurstEnd = process->CPUBurst;
+    process->IOBurstEnd = process->IOBurst;
+}
+
+/**
+ * Moves on to the next CPU burst once the current one has been used up (the same burst again for (A B C M) input).
+ * A trace process then blocks for the I/O burst paired with the CPU burst that just ended.
+ */
+void finishCPUBurst(_process* process)
+{
+    if (process->traceBursts)
+    {
+        process->IOBurst = process->traceBursts[2 * process->CPUBurstIndex + 1];
+        process->IOBurstEnd = process->currentIOBlockedTime + process->IOBurst;
+        if (process->CPUBurstIndex + 1 < process->numTraceBursts)
+        {
+            process->CPUBurst = process->traceBursts[2 * ++process->CPUBurstIndex];
+        }
+    }
+    process->CPUBurstEnd = process->currentCPUTimeRun + process->CPUBurst;
+}
+
+// Starts counting towards the next I/O wait once the current one has been served (blocks on quantum expiry reuse the current I/O burst)
+void finishIOBurst(_process* process)
+{
+    process->IOBurstEnd = process->currentIOBlockedTime + process->IOBurst;
 }
 
 // Returns 1 if all processes have terminated, 0 otherwise
@@ -249,7 +589,7 @@ void cycle(_process* process)
         ++process->currentWaitingTime;
         break;
     case 2:
-        ++process->currentCPUTimeRun;
+        if (!IS_SWITCHING_CONTEXT) ++process->currentCPUTimeRun; // no progress while the switch is paid for
         break;
     case 3:
         ++process->currentIOBlockedTime;
@@ -266,6 +606,38 @@ void initializeGlobals(void)
     TOTAL_STARTED_PROCESSES = 0;
     TOTAL_FINISHED_PROCESSES = 0;
     TOTAL_NUMBER_OF_CYCLES_SPENT_BLOCKED = 0;
+    TOTAL_CONTEXT_SWITCHES = 0;
+    TOTAL_SWITCH_OVERHEAD_CYCLES = 0;
+    SWITCH_CYCLES_REMAINING = 0;
+    IS_SWITCHING_CONTEXT = false;
+    LAST_RUN_PROCESS = NULL;
+}
+
+/**
+ * Dispatches the CPU to processToRun for this cycle. Switching from another process costs CONTEXT_SWITCH_COST cycles,
+ * plus CACHE_WARMUP_COST if processToRun has run before, during which processToRun makes no progress.
+ * The first dispatch of a simulation and re-dispatching the process that ran last are free.
+ * Sets IS_SWITCHING_CONTEXT for the current cycle.
+ */
+void dispatch(_process* processToRun)
+{
+    if (processToRun != LAST_RUN_PROCESS)
+    {
+        if (LAST_RUN_PROCESS)
+        {
+            ++TOTAL_CONTEXT_SWITCHES;
+            SWITCH_CYCLES_REMAINING = CONTEXT_SWITCH_COST;
+            if (processToRun->currentCPUTimeRun) SWITCH_CYCLES_REMAINING += CACHE_WARMUP_COST; // its cache state is gone
+        }
+        LAST_RUN_PROCESS = processToRun;
+    }
+
+    IS_SWITCHING_CONTEXT = (SWITCH_CYCLES_REMAINING > 0);
+    if (IS_SWITCHING_CONTEXT)
+    {
+        --SWITCH_CYCLES_REMAINING;
+        ++TOTAL_SWITCH_OVERHEAD_CYCLES;
+    }
 }
 
 // Returns 1 if a process should terminate, 0 otherwise
@@ -281,14 +653,22 @@ void terminate(_process* process)
 }
 
 // Returns 1 if a running process should be blocked, 0 otherwise
-int hasBlocked(_process* process) { return ((process->status == 2) && (process->currentCPUTimeRun) && (process->currentCPUTimeRun % process->CPUBurst == 0)); }
+int hasBlocked(_process* process) { return ((process->status == 2) && (process->currentCPUTimeRun) && (process->currentCPUTimeRun >= process->CPUBurstEnd)); }
 
 // Returns 1 if a blocked process has finished its I/O time, 0 otherwise
-int hasFinishedIO(_process* process) { return ((process->status == 3) && (process->currentIOBlockedTime) && (process->currentIOBlockedTime % process->IOBurst == 0)); }
+int hasFinishedIO(_process* process) { return ((process->status == 3) && (process->currentIOBlockedTime) && (process->currentIOBlockedTime >= process->IOBurstEnd)); }
 
 // Returns 1 if a non-running process has arrived on this cycle, 0 otherwise
 int hasArrived(_process* process) { return ((process->currentWaitingTime == 1) && (CURRENT_CYCLE == process->A + 1)); }
 
+// Takes a process off the front of the ready queue and returns the next one, so a stale link can't dispatch it again later
+_process* dequeue(_process* process)
+{
+    _process* next = process->nextInReadyQueue;
+    process->nextInReadyQueue = NULL;
+    return next;
+}
+
 // Determines and sets the queue order for a given process that has been deemed ready
 void determineQueue(_process* processToRun, _process* currentProcess, int numReady, int newlyReady)
 {
@@ -367,6 +747,26 @@ void determineSJF(_process* processToRun, _process* currentProcess, int numReady
 }
 
 
+// Prints how to run the scheduler to standard error and returns the exit code for a bad command line
+int printUsage(const char* program_name)
+{
+    fprintf(stderr, "usage: %s <input> [--switch-cost <cycles>] [--warmup-cost <cycles>]\n", program_name);
+    fprintf(stderr, "       %s --convert <input.csv> <output.trace>\n", program_name);
+    fprintf(stderr, "costs are whole numbers of cycles from 0 to %u\n", MAX_DISPATCH_COST);
+    return 1;
+}
+
+// Parses a dispatch cost given on the command line; returns 1 if it is a whole number no larger than MAX_DISPATCH_COST, 0 otherwise
+int parseCost(const char* str, uint32_t* cost)
+{
+    char* end;
+    if (str[0] < '0' || str[0] > '9') return 0; // strtoul would accept a sign or leading whitespace
+    unsigned long value = strtoul(str, &end, 10);
+    if (*end != '\0' || value > MAX_DISPATCH_COST) return 0;
+    *cost = (uint32_t)value;
+    return 1;
+}
+
 /**
  * The magic starts from here
  */
@@ -386,20 +786,50 @@ int main(int argc, char* argv[])
         GREATER THAN THREE PROCESSES MAY BREAK THE SIMULATIONS.
     */
 
+    // CONVERTING A CSV TRACE: ./scheduler --convert <input.csv> <output.trace>
+    if (argc == 4 && strcmp(argv[1], "--convert") == 0) return convertCSVToTrace(argv[2], argv[3]);
+
+    // DISPATCH COSTS: ./scheduler <input> [--switch-cost <cycles>] [--warmup-cost <cycles>]
+    if (argc < 2 || argv[1][0] == '-') return printUsage(argv[0]);
+    for (int i = 2; i < argc; i += 2)
+    {
+        uint32_t* cost = NULL;
+        if (strcmp(argv[i], "--switch-cost") == 0) cost = &CONTEXT_SWITCH_COST;
+        else if (strcmp(argv[i], "--warmup-cost") == 0) cost = &CACHE_WARMUP_COST;
+
+        if (!cost || i + 1 == argc || !parseCost(argv[i + 1], cost)) return printUsage(argv[0]);
+    }
+
     // READING PROCESSES FROM FILE
-    FILE* process_file = fopen(argv[1], "r"); // open file
-    fscanf(process_file, "%d", &total_num_of_process); // read num of processes
-    TOTAL_CREATED_PROCESSES = total_num_of_process;
+    _process* process_list = NULL;
+    int trace_loaded = loadTrace(argv[1], &process_list, &total_num_of_process); // binary traces are mapped, not parsed
+    if (trace_loaded < 0) return 1;
+
+    if (!trace_loaded)
+    {
+        FILE* process_file = fopen(argv[1], "r"); // open file
+        if (!process_file)
+        {
+            perror(argv[1]);
+            return 1;
+        }
+        fscanf(process_file, "%d", &total_num_of_process); // read num of processes
 
-    _process* process_list = (_process*)malloc(total_num_of_process * sizeof(_process)); // Creates a container for all processes
+        process_list = (_process*)malloc(total_num_of_process * sizeof(_process)); // Creates a container for all processes
 
-    for (int i = 0; i < total_num_of_process; ++i) // loop 'total_num_of_process' times
+        for (int i = 0; i < total_num_of_process; ++i) // loop 'total_num_of_process' times
+        {
+            readProcess(process_file, &process_list[i]); // read all processes
+        }
+        fclose(process_file); // close the file
+    }
+    TOTAL_CREATED_PROCESSES = total_num_of_process;
+
+    for (int i = 0; i < total_num_of_process; ++i)
     {
-        readProcess(process_file, &process_list[i]); // read all processes
         process_list[i].processID = i;
         initializeProcess(&process_list[i]);
     }
-    fclose(process_file); // close the file
 
 
     ///////////////////////// FIRST COME FIRST SERVE /////////////////////////
@@ -426,8 +856,13 @@ int main(int argc, char* argv[])
                 processToRun->isFirstTimeRunning = false;
             }
             if (processToRun->status == 4) processToRun = NULL; // don't run a terminated process
-            else processToRun->status = 2;
+            else
+            {
+                processToRun->status = 2;
+                dispatch(processToRun);
+            }
         }
+        if (!processToRun) IS_SWITCHING_CONTEXT = false;
 
         for (int i = 0; i < TOTAL_CREATED_PROCESSES; ++i)
         {
@@ -448,6 +883,7 @@ int main(int argc, char* argv[])
             // check if should be blocked
             if (hasBlocked(currentProcess))
             {
+                finishCPUBurst(currentProcess);
                 currentProcess->status = 3;
                 continue;
             }
@@ -455,6 +891,7 @@ int main(int argc, char* argv[])
             // check if should be ready
             if (hasFinishedIO(currentProcess) || hasArrived(currentProcess))
             {
+                if (hasFinishedIO(currentProcess)) finishIOBurst(currentProcess);
                 currentProcess->status = 1;
         
                 if (processToRun)
@@ -477,7 +914,7 @@ int main(int argc, char* argv[])
         {
             if (processToRun->status != 2) // don't switch to a terminated process
             {
-                processToRun = processToRun->nextInReadyQueue;
+                processToRun = dequeue(processToRun);
                 if (numReady) --numReady;
             }
         }
@@ -525,9 +962,11 @@ int main(int argc, char* argv[])
             else
             {
                 processToRun->status = 2;
-                ++consecutiveCyclesRunning;
+                dispatch(processToRun);
+                if (!IS_SWITCHING_CONTEXT) ++consecutiveCyclesRunning; // the switch does not use up the time slice
             }
         }
+        if (!processToRun) IS_SWITCHING_CONTEXT = false;
 
         for (int i = 0; i < TOTAL_CREATED_PROCESSES; ++i)
         {
@@ -549,6 +988,7 @@ int main(int argc, char* argv[])
             if (hasBlocked(currentProcess) || 
                 consecutiveCyclesRunning >= currentProcess->quantum) // NEW FOR RR - if a process has been running for the time slice, block it
             {
+                if (hasBlocked(currentProcess)) finishCPUBurst(currentProcess);
                 currentProcess->status = 3;
                 continue;
             }
@@ -556,6 +996,7 @@ int main(int argc, char* argv[])
             // check if should be ready
             if (hasFinishedIO(currentProcess) || hasArrived(currentProcess))
             {
+                if (hasFinishedIO(currentProcess)) finishIOBurst(currentProcess);
                 currentProcess->status = 1;
 
                 if (processToRun)
@@ -579,7 +1020,7 @@ int main(int argc, char* argv[])
         {
             if (processToRun->status != 2) // don't switch to a terminated process
             {
-                processToRun = processToRun->nextInReadyQueue;
+                processToRun = dequeue(processToRun);
                 consecutiveCyclesRunning = 0; // NEW FOR RR - reset consecutive cycles counter
                 if (numReady) --numReady;
             }
@@ -624,8 +1065,13 @@ int main(int argc, char* argv[])
                 processToRun->isFirstTimeRunning = false;
             }
             if (processToRun->status == 4) processToRun = NULL; // don't run a terminated process
-            else processToRun->status = 2;
+            else
+            {
+                processToRun->status = 2;
+                dispatch(processToRun);
+            }
         }
+        if (!processToRun) IS_SWITCHING_CONTEXT = false;
 
         for (int i = 0; i < TOTAL_CREATED_PROCESSES; ++i)
         {
@@ -646,6 +1092,7 @@ int main(int argc, char* argv[])
             // check if should be blocked
             if (hasBlocked(currentProcess))
             {
+                finishCPUBurst(currentProcess);
                 currentProcess->status = 3;
                 continue;
             }
@@ -653,6 +1100,7 @@ int main(int argc, char* argv[])
             // check if should be ready
             if (hasFinishedIO(currentProcess) || hasArrived(currentProcess))
             {
+                if (hasFinishedIO(currentProcess)) finishIOBurst(currentProcess);
                 currentProcess->status = 1;
 
                 if (processToRun)
@@ -675,7 +1123,7 @@ int main(int argc, char* argv[])
         {
             if (processToRun->status != 2) // don't switch to a terminated process
             {
-                processToRun = processToRun->nextInReadyQueue;
+                processToRun = dequeue(processToRun);
                 if (numReady) --numReady;
             }
         }
@@ -689,6 +1137,8 @@ int main(int argc, char* argv[])
 
 
     fclose(randNumFile);
+    freeTrace();
+    free(process_list);
 
 
     return 0;